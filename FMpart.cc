@@ -1,4 +1,8 @@
 #include <assert.h>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <fstream>
@@ -6,6 +10,10 @@
 #include <random>
 #include <vector>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif // _WIN32
+
 #include "gain_container.h"
 #include "graph.h"
 
@@ -16,6 +24,103 @@ bool verbose_debug = false;
 #define ON_DEBUG(op) ;
 #endif // NDEBUG
 
+using Clock = std::chrono::steady_clock;
+
+volatile std::sig_atomic_t interrupted = 0;
+
+void handle_interrupt(int) {
+    interrupted = 1;
+}
+
+// wall clock budget for the whole run, shared by every pass (and every start)
+struct Deadline {
+    bool limited = false;
+    Clock::time_point end;
+
+    bool expired(Clock::time_point now = Clock::now()) const {
+        return interrupted || (limited && now >= end);
+    }
+};
+
+// keeps the best partitionment seen so far and periodically flushes it to the output file
+// file is replaced atomically: written next to it and renamed over it
+class Checkpoint {
+public:
+    Checkpoint(const char *output, double interval, unsigned possible_disbalance) :
+        output(output), interval(interval), possible_disbalance(possible_disbalance),
+        last_write(Clock::now()) {}
+
+    // balanced solution always wins over unbalanced one (e.g. random initial partitionment)
+    void offer(unsigned cost, int disbalance, const std::vector<bool>& partitionment) {
+        bool balanced = (unsigned) abs(disbalance) <= possible_disbalance;
+        bool best_balanced = (unsigned) abs(best_disbalance) <= possible_disbalance;
+
+        if (!best_partitionment.empty() &&
+                (best_balanced > balanced ||
+                 (best_balanced == balanced &&
+                  (cost > best_cost ||
+                   (cost == best_cost && abs(disbalance) >= abs(best_disbalance))))))
+            return;
+
+        best_cost = cost;
+        best_disbalance = disbalance;
+        best_partitionment = partitionment;
+        dirty = true;
+    }
+
+    bool is_due(Clock::time_point now = Clock::now()) const {
+        return interval > 0 &&
+            std::chrono::duration<double>(now - last_write).count() >= interval;
+    }
+
+    void write_if_due() {
+        if (is_due())
+            write();
+    }
+
+    // false if output file could not be written, it is left as it was then
+    bool write() {
+        last_write = Clock::now();
+        if (!dirty)
+            return true;
+
+        std::string tmp = output + ".tmp";
+        std::ofstream out(tmp);
+        Graph::print_partitionment(out, best_partitionment);
+        out.close();
+
+        if (!out) {
+            std::cout << "Failed to write checkpoint " << tmp << '\n';
+            return false;
+        }
+#ifdef _WIN32
+        std::remove(output.c_str()); // rename does not replace existing file on windows
+#endif // _WIN32
+        if (std::rename(tmp.c_str(), output.c_str()) != 0) {
+            std::cout << "Failed to write checkpoint " << output << '\n';
+            return false;
+        }
+
+        dirty = false;
+        return true;
+    }
+
+    unsigned get_best_cost() const { return best_cost; }
+    int get_best_disbalance() const { return best_disbalance; }
+    const auto& get_best_partitionment() const { return best_partitionment; }
+
+private:
+    std::string output;
+    double interval;
+    unsigned possible_disbalance;
+    Clock::time_point last_write;
+
+    unsigned best_cost = (unsigned) -1;
+    int best_disbalance = 0;
+    std::vector<bool> best_partitionment;
+    bool dirty = false;
+};
+
 std::vector<bool> static_initial_partitionment(unsigned num_cells) {
     std::vector<bool> partitionment(num_cells);
 
@@ -39,8 +144,11 @@ std::vector<bool> random_initial_partitionment(unsigned num_cells) {
 }
 
 void print_usage() {
-    std::cout << "Usage: ./FMpart input_filename [--dump dump_file.dot] [-m]"
+    std::cout << "Usage: ./FMpart input_filename [--dump dump_file.dot] [-m] [--compact]"
         << "[--disbalance DISBALANCE] [--initial (static|random)]"
+        << "[--time-limit SECONDS] [--checkpoint-interval SECONDS]"
+        << '\n'
+        << "--compact drops duplicate pins of a net, cut cost may differ from default mode then"
         << '\n';
 }
 
@@ -57,30 +165,40 @@ std::vector<bool> initial_partitionment(unsigned num_cells, const char *type) {
 }
 
 void update_gain(const Graph& g, GainContainer *gc, const Move& m) {
-    for (const auto net: g.ith_cell_nets(m.cell)) {
+    g.for_each_cell_net(m.cell, [&](unsigned net) {
         if (g.get_net_cells_partition(net, m.to) == 0) { // adding net's first cell to dest
-            for (const auto cell: g.ith_net_cells(net))
+            g.for_each_net_cell(net, [&](unsigned cell) {
                 gc->update_gain(cell, 1);
+            });
         }
         if (g.get_net_cells_partition(net, m.from) == 1) { // removing net's last cell
-            for (const auto cell: g.ith_net_cells(net))
+            g.for_each_net_cell(net, [&](unsigned cell) {
                 gc->update_gain(cell, -1);
+            });
         }
 
         if (g.get_net_cells_partition(net, m.from) == 2) { // leaving one behind
-            for (const auto cell: g.ith_net_cells(net))
+            g.for_each_net_cell(net, [&](unsigned cell) {
                 if (g.get_ith_cell_partition(cell) == m.from) // updating m.cell as well
                     gc->update_gain(cell, 1);
+            });
         }
         if (g.get_net_cells_partition(net, m.to) == 1) { // adding second cell to dest
-            for (const auto cell: g.ith_net_cells(net))
+            g.for_each_net_cell(net, [&](unsigned cell) {
                 if (g.get_ith_cell_partition(cell) == m.to)
                     gc->update_gain(cell, -1);
+            });
         }
-    }
+    });
 }
 
-unsigned FMpass(Graph *g, GainContainer *gc, unsigned possible_disbalance) {
+// reading clock may be a syscall, which is comparable to a cheap move
+const unsigned CLOCK_POLL_PERIOD = 16;
+
+// stops early if deadline is reached, in this case returns best partitionment found before that
+// (or leaves initial one if none was balanced)
+unsigned FMpass(Graph *g, GainContainer *gc, unsigned possible_disbalance,
+        const Deadline& deadline, Checkpoint *checkpoint) {
     gc->initialize_gain(*g);
 
     unsigned solution_cost = g->get_partitionment_cost();
@@ -90,6 +208,8 @@ unsigned FMpass(Graph *g, GainContainer *gc, unsigned possible_disbalance) {
     unsigned best_disbalance = possible_disbalance + 1;
 
     std::vector<bool> best_partitionment;
+    std::vector<bool> pass_start_partitionment = g->get_partitionment();
+    unsigned move_count = 0;
 
     ON_DEBUG(
         std::cout << "new pass, solution cost = " << solution_cost <<
@@ -99,6 +219,17 @@ unsigned FMpass(Graph *g, GainContainer *gc, unsigned possible_disbalance) {
     )
 
     while (!gc->empty()) {
+        if (++move_count % CLOCK_POLL_PERIOD == 0) {
+            auto now = Clock::now();
+            if (deadline.expired(now))
+                break;
+
+            if (checkpoint->is_due(now) && !best_partitionment.empty()) {
+                checkpoint->offer(best_solution, best_disbalance, best_partitionment);
+                checkpoint->write();
+            }
+        }
+
         Move m = gc->best_move(g->get_disbalance(), possible_disbalance);
 
         solution_cost -= m.gain;
@@ -127,20 +258,60 @@ unsigned FMpass(Graph *g, GainContainer *gc, unsigned possible_disbalance) {
         )
     }
 
+    if (best_partitionment.empty()) { // no balanced solution, e.g. interrupted early
+        g->set_partitionment(std::move(pass_start_partitionment));
+        return g->get_partitionment_cost();
+    }
+
     g->set_partitionment(std::move(best_partitionment));
 
     return best_solution;
 }
 
+// peak resident set size in kilobytes, 0 if unknown
+unsigned long peak_memory_usage() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return usage.ru_maxrss; // kilobytes on linux
+#endif // _WIN32
+}
+
+void print_memory_usage(const Graph& g) {
+    unsigned long peak = peak_memory_usage();
+    if (peak == 0)
+        return;
+
+    std::cout << "Memory: peak=" << peak / 1024. << "MB, pins=" << g.get_pin_count() <<
+        ", per pin=" << (g.get_pin_count() ? peak * 1024. / g.get_pin_count() : 0) << "B\n";
+}
+
 struct Parameters {
     unsigned disbalance = 2;
     bool modified = false;
+    bool compact = false;
     const char *dump = nullptr;
     const char *init_part = "static";
+    double time_limit = 0; // seconds, 0 for unlimited
+    double checkpoint_interval = 60; // seconds, 0 to write only at the end
 };
 
-void FM(const char *input, const char *output, const Parameters& p) {
-    Graph g(input);
+// false if the result could not be written
+bool FM(const char *input, const char *output, const Parameters& p) {
+    Deadline deadline;
+    if (p.time_limit > 0) {
+        deadline.limited = true;
+        deadline.end = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(p.time_limit));
+    }
+
+    Checkpoint checkpoint(output, p.checkpoint_interval, p.disbalance);
+
+    Graph g(input, p.compact);
     GainContainer gc(g.get_max_degree(), g.get_cell_count(), p.modified);
 
     g.set_partitionment(initial_partitionment(g.get_cell_count(), p.init_part));
@@ -150,20 +321,33 @@ void FM(const char *input, const char *output, const Parameters& p) {
     std::cout << "Initial: cost=" << current_cost << ", disbalance=" <<
         g.get_disbalance() << '\n';
 
+    checkpoint.offer(current_cost, g.get_disbalance(), g.get_partitionment());
+
+    // installed only now: until there is a partitionment to write,
+    // default handlers terminate reading of the graph right away
+    std::signal(SIGINT, handle_interrupt);
+    std::signal(SIGTERM, handle_interrupt);
+
     unsigned iteration_count = 0;
 
     std::clock_t start_time = std::clock();
 
     do {
+        if (deadline.expired()) // do not pay for gain initialization of a pass to be dropped
+            break;
+
         ON_DEBUG(
         if (p.dump)
             g.dump(p.dump);
         )
 
         old_cost = current_cost;
-        current_cost = FMpass(&g, &gc, p.disbalance);
+        current_cost = FMpass(&g, &gc, p.disbalance, deadline, &checkpoint);
         ++iteration_count;
 
+        checkpoint.offer(current_cost, g.get_disbalance(), g.get_partitionment());
+        checkpoint.write_if_due();
+
         auto elapsed_time = (double) (std::clock() - start_time) / CLOCKS_PER_SEC;
 
         std::cout << "Heartbeat: iteration=" << iteration_count <<
@@ -178,15 +362,27 @@ void FM(const char *input, const char *output, const Parameters& p) {
 
     std::clock_t end_time = std::clock();
 
+    if (interrupted)
+        std::cout << "Interrupted, writing best partitionment found\n";
+    else if (deadline.expired())
+        std::cout << "Time limit reached, writing best partitionment found\n";
+
+    // last pass can end up worse than previous one
+    g.set_partitionment(checkpoint.get_best_partitionment());
+
     std::cout << "Results: time=" << (double) (end_time - start_time) / CLOCKS_PER_SEC <<
         ", iterations=" << iteration_count <<
-        ", cost=" << current_cost <<
+        ", cost=" << checkpoint.get_best_cost() <<
         ", disbalance=" << g.get_disbalance() << '\n';
 
-    g.print_partitionment(output);
+    bool written = checkpoint.write();
+
+    print_memory_usage(g);
 
     if (p.dump)
         g.dump(p.dump);
+
+    return written;
 }
 
 void check_argc(int i, int argc) {
@@ -197,6 +393,23 @@ void check_argc(int i, int argc) {
     }
 }
 
+// about 30 years: keeps deadline within range of steady_clock
+const double MAX_SECONDS = 1e9;
+
+// non-negative, possibly fractional number of seconds
+// typos are fatal rather than silently meaning 0, inf and nan are rejected too
+double parse_seconds(const char *arg) {
+    char *end = nullptr;
+    double value = strtod(arg, &end);
+    if (end == arg || *end != '\0' || !(value >= 0 && value <= MAX_SECONDS)) {
+        std::cout << "Invalid number of seconds " << arg << '\n';
+        print_usage();
+        exit(1);
+    }
+
+    return value;
+}
+
 int main(int argc, char **argv) {
     char *input_filename = nullptr;
     Parameters p;
@@ -213,8 +426,18 @@ int main(int argc, char **argv) {
             check_argc(i + 1, argc);
             p.init_part = argv[i + 1];
             ++i;
+        } else if (strcmp(argv[i], "--time-limit") == 0) {
+            check_argc(i + 1, argc);
+            p.time_limit = parse_seconds(argv[i + 1]);
+            ++i;
+        } else if (strcmp(argv[i], "--checkpoint-interval") == 0) {
+            check_argc(i + 1, argc);
+            p.checkpoint_interval = parse_seconds(argv[i + 1]);
+            ++i;
         } else if (strcmp(argv[i], "-m") == 0) {
             p.modified = true;
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            p.compact = true;
 #ifndef NDEBUG
         } else if (strcmp(argv[i], "--verbose_debug") == 0) {
             verbose_debug = true;
@@ -235,5 +458,5 @@ int main(int argc, char **argv) {
     }
 
     std::string output_filename = std::string(input_filename) + ".part.2";
-    FM(input_filename, output_filename.c_str(), p);
+    return FM(input_filename, output_filename.c_str(), p) ? 0 : 1;
 }
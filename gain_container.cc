@@ -1,5 +1,6 @@
+#include <algorithm>
 #include <assert.h>
-#include <list>
+#include <cstdint>
 #include <ostream>
 #include <vector>
 
@@ -14,58 +15,82 @@
 
 GainContainer::GainContainer(unsigned max_gain, unsigned num_cells, bool lifo) :
     MAX_GAIN(max_gain), num_cells(num_cells) {
-    buckets[0].resize(max_gain * 2 + 1);
-    buckets[1].resize(max_gain * 2 + 1);
+    buckets[0].resize(max_gain * 2 + 1, { NIL, NIL });
+    buckets[1].resize(max_gain * 2 + 1, { NIL, NIL });
 
     cells.resize(num_cells);
 
     this->lifo = lifo;
 }
 
+// inserts cell into the bucket of its current gain
+void GainContainer::push_front(unsigned cell) {
+    CellInfo& info = cells[cell];
+    Bucket& bucket = gain_bucket(info.partition(), info.gain());
+
+    info.prev = NIL;
+    info.next = bucket.head;
+    if (bucket.head != NIL)
+        cells[bucket.head].prev = cell;
+    else
+        bucket.tail = cell;
+    bucket.head = cell;
+}
+
+// removes cell from the bucket of its current gain
+void GainContainer::erase(unsigned cell) {
+    CellInfo& info = cells[cell];
+    Bucket& bucket = gain_bucket(info.partition(), info.gain());
+
+    if (info.prev != NIL)
+        cells[info.prev].next = info.next;
+    else
+        bucket.head = info.next;
+
+    if (info.next != NIL)
+        cells[info.next].prev = info.prev;
+    else
+        bucket.tail = info.prev;
+}
+
 void GainContainer::update_gain(unsigned cell, int value) {
-    if (cells[cell].locked)
+    if (cells[cell].locked())
         return;
 
     CellInfo& info = cells[cell];
 
-    int new_gain = info.gain + value;
+    int old_gain = info.gain();
+    int new_gain = old_gain + value;
 
-    gain_bucket(info.partition, info.gain).erase(cells[cell].it);
-    gain_bucket(info.partition, new_gain).push_front(cell);
-    info.it = gain_bucket(info.partition, new_gain).begin(); // iterator to the last element
-    assert(*(info.it) == cell);
+    erase(cell);
+    info.set_gain(new_gain);
+    push_front(cell);
+    assert(gain_bucket(info.partition(), new_gain).head == cell);
 
-    if (new_gain > current_max_gain[info.partition]) // increasing max gain
-        current_max_gain[info.partition] = new_gain;
-    else if (info.gain == current_max_gain[info.partition]) // possibly, decreasing max_gain
-        update_max_gain(current_max_gain[info.partition], info.partition);
-
-    info.gain = new_gain;
+    if (new_gain > current_max_gain[info.partition()]) // increasing max gain
+        current_max_gain[info.partition()] = new_gain;
+    else if (old_gain == current_max_gain[info.partition()]) // possibly, decreasing max_gain
+        update_max_gain(current_max_gain[info.partition()], info.partition());
 }
 
 void GainContainer::initialize_gain(const Graph& g) {
-    for (auto& bucket: buckets[0])
-        bucket.clear();
-    for (auto& bucket: buckets[1])
-        bucket.clear();
+    std::fill(buckets[0].begin(), buckets[0].end(), Bucket { NIL, NIL });
+    std::fill(buckets[1].begin(), buckets[1].end(), Bucket { NIL, NIL });
 
     for (unsigned i = 0; i < cells.size(); ++i) {
-        CellInfo& info = cells[i];
-        info.gain = 0;
-        info.locked = false;
-        info.partition = g.get_ith_cell_partition(i);
+        bool partition = g.get_ith_cell_partition(i);
+        int gain = 0;
 
-        for (auto net: g.ith_cell_nets(i)) {
-            if (g.get_net_cells_partition(net, info.partition) == 1) // F(n)
-                ++info.gain;
+        g.for_each_cell_net(i, [&](unsigned net) {
+            if (g.get_net_cells_partition(net, partition) == 1) // F(n)
+                ++gain;
 
-            if (g.get_net_cells_partition(net, !info.partition) == 0) // T(n)
-                --info.gain;
-        }
+            if (g.get_net_cells_partition(net, !partition) == 0) // T(n)
+                --gain;
+        });
 
-        gain_bucket(info.partition, info.gain).push_front(i);
-        info.it = gain_bucket(info.partition, info.gain).begin();
-        assert(*(info.it) == i);
+        cells[i].set(gain, false, partition);
+        push_front(i);
     }
     
     update_max_gain(MAX_GAIN, 0);
@@ -75,14 +100,14 @@ void GainContainer::initialize_gain(const Graph& g) {
 } 
 
 void GainContainer::lock_cell(unsigned i) {
-    dassert(!cells[i].locked);
+    dassert(!cells[i].locked());
     CellInfo& info = cells[i];
 
-    info.locked = true;
-    gain_bucket(info.partition, info.gain).erase(info.it);
+    erase(i);
+    info.lock();
     ++num_locked;
     
-    update_max_gain(current_max_gain[info.partition], info.partition);
+    update_max_gain(current_max_gain[info.partition()], info.partition());
 }
 
 Move GainContainer::best_move(int disbalance, int max_disbalance) const {
@@ -98,18 +123,18 @@ Move GainContainer::best_move(int disbalance, int max_disbalance) const {
         m.from = 0;
         m.to = 1;
         if (lifo)
-            m.cell = gain_bucket(0, m.gain).front();
+            m.cell = gain_bucket(0, m.gain).head;
         else
-            m.cell = gain_bucket(0, m.gain).back();
+            m.cell = gain_bucket(0, m.gain).tail;
     }
     if (is_part1_available && m.gain < current_max_gain[1]) {
         m.gain = current_max_gain[1];
         m.from = 1;
         m.to = 0;
         if (lifo)
-            m.cell = gain_bucket(1, m.gain).front();
+            m.cell = gain_bucket(1, m.gain).head;
         else
-            m.cell = gain_bucket(1, m.gain).back();
+            m.cell = gain_bucket(1, m.gain).tail;
     }
 
     dassert(m.gain > (int) -MAX_GAIN);
@@ -120,7 +145,7 @@ Move GainContainer::best_move(int disbalance, int max_disbalance) const {
 // descending search for next max gain
 // -MAX_GAIN - 1 if not found: renders this partition useless
 void GainContainer::update_max_gain(int max_gain, bool partition) {
-    while (max_gain >= (int) -MAX_GAIN && gain_bucket(partition, max_gain).empty())
+    while (max_gain >= (int) -MAX_GAIN && is_bucket_empty(partition, max_gain))
         --max_gain;
 
     current_max_gain[partition] = max_gain;
@@ -133,7 +158,7 @@ void GainContainer::dump(std::ostream& out) const {
         out << "\t[" << partition << "]:\n";
         for (int i = -MAX_GAIN; i <= (int) MAX_GAIN; ++i) {
             out << "\t\t[" << i << "]:";
-            for (auto cell: gain_bucket(partition, i))
+            for (auto cell = gain_bucket(partition, i).head; cell != NIL; cell = cells[cell].next)
                 out << ' ' << cell;
             out << '\n';
         }
@@ -141,10 +166,10 @@ void GainContainer::dump(std::ostream& out) const {
 
     out << "\tfree list:\n";
     for (unsigned i = 0; i < cells.size(); ++i) {
-        out << "\t\t[" << i << "]: partition=" << cells[i].partition << " ";
-        if (cells[i].locked)
+        out << "\t\t[" << i << "]: partition=" << cells[i].partition() << " ";
+        if (cells[i].locked())
             out << "locked\n";
         else
-            out << "gain=" << cells[i].gain << " *it=" << *(cells[i].it) << '\n';
+            out << "gain=" << cells[i].gain() << '\n';
     }
 }
@@ -1,7 +1,7 @@
 #ifndef GAIN_CONTAINER_H
 #define GAIN_CONTAINER_H
 
-#include <list>
+#include <cstdint>
 #include <ostream>
 #include <vector>
 
@@ -25,19 +25,37 @@ public:
     
     Move best_move(int disbalance, int max_disbalance) const;
 
+    // 12 bytes per cell: gain, locked and partition packed in one word
+    // plus intrusive links of the bucket list the cell is in
     struct CellInfo {
-        int gain;
-        std::list<unsigned>::iterator it;
-        bool locked;
-        bool partition;
+        uint32_t word;
+        uint32_t prev, next;
+
+        int gain() const { return (int32_t) word >> 2; } // arithmetic shift keeps the sign
+        bool locked() const { return word & 2; }
+        bool partition() const { return word & 1; }
+
+        void set(int gain, bool locked, bool partition)
+            { word = ((uint32_t) gain << 2) | (locked << 1) | partition; }
+        void set_gain(int gain) { set(gain, locked(), partition()); }
+        void lock() { word |= 2; }
+    };
+
+    struct Bucket {
+        uint32_t head, tail;
     };
 
+    static const uint32_t NIL = UINT32_MAX;
+
     void dump(std::ostream& out) const;
 
 private:
     void update_max_gain(int max_gain, bool partition);
 
-    std::vector<std::list<unsigned>> buckets[2];
+    void push_front(unsigned cell);
+    void erase(unsigned cell);
+
+    std::vector<Bucket> buckets[2];
     std::vector<CellInfo> cells;
     const unsigned MAX_GAIN;
     int current_max_gain[2];
@@ -45,6 +63,7 @@ private:
     auto& gain_bucket(bool part, int gain) { return buckets[part][gain + MAX_GAIN]; }
     const auto& gain_bucket(bool part, int gain) const
         { return buckets[part][gain + MAX_GAIN]; }
+    bool is_bucket_empty(bool part, int gain) const { return gain_bucket(part, gain).head == NIL; }
 
     unsigned num_cells;
     unsigned num_locked = 0;
@@ -8,7 +8,7 @@
 
 #include "graph.h"
 
-Graph::Graph(const char *file) {
+Graph::Graph(const char *file, bool compact) : compact(compact) {
     std::ifstream in(file);
 
     int cell_num = 0, net_num = 0, fmt = 0;
@@ -19,11 +19,24 @@ Graph::Graph(const char *file) {
     str_stream >> net_num >> cell_num >> fmt;
     assert(fmt == 0); // weighted nets and cells are not supported
 
-    cells.resize(cell_num);
     partitionment.resize(cell_num);
-    nets.resize(net_num);
+    net_count = net_num;
     disbalance = cell_num;
 
+    if (compact)
+        read_compact(in);
+    else
+        read_lists(in);
+
+    in.close();
+}
+
+void Graph::read_lists(std::istream& in) {
+    cells.resize(get_cell_count());
+    nets.resize(net_count);
+
+    std::string line;
+    std::istringstream str_stream;
     int net_idx = 0;
     while (getline(in, line)) {
         if (line[0] == '%') // comment line in hgr file
@@ -36,11 +49,51 @@ Graph::Graph(const char *file) {
             --cell; // internally, cells numbered from 0
             nets[net_idx].push_back(cell);
             cells[cell].push_back(net_idx);
+            ++pin_count;
         }
         ++net_idx;
     }
+}
+
+// nets are compressed as they are read, cells are built from them afterwards
+// so no uncompressed copy of pins is kept at any point
+void Graph::read_compact(std::istream& in) {
+    // varint of a delta is never longer than the decimal number with its separator,
+    // so the rest of the file bounds compressed size of nets
+    // pipes (e.g. decompressed input) can not be measured, nets just grow then
+    std::streamoff file_rest = 0;
+    auto start = in.tellg();
+    if (start != -1 && in.seekg(0, std::ios::end)) {
+        file_rest = in.tellg() - start;
+        in.seekg(start);
+    }
+    in.clear();
+    packed_nets.reserve(net_count, file_rest > 0 ? file_rest : 0);
 
-    in.close();
+    std::string line;
+    std::istringstream str_stream;
+    std::vector<unsigned> net;
+    while (getline(in, line)) {
+        if (line[0] == '%') // comment line in hgr file
+            continue;
+
+        int cell = 0;
+        str_stream.str(line);
+        str_stream.clear();
+        net.clear();
+        while (str_stream >> cell)
+            net.push_back(cell - 1); // internally, cells numbered from 0
+
+        packed_nets.push_row(&net); // duplicate pins are dropped
+        pin_count += net.size();
+    }
+
+    for (unsigned i = packed_nets.row_count(); i < net_count; ++i) { // missing lines
+        net.clear();
+        packed_nets.push_row(&net);
+    }
+
+    packed_cells.build_transposed(packed_nets, get_cell_count());
 }
 
 void Graph::dump(const char* file) const {
@@ -65,7 +118,7 @@ void Graph::dump(std::ostream& out) const {
     // nodes
     // internal nets to partition 0
     out << "{ rank = min; \n";
-    for (unsigned i = 0; i < nets.size(); ++i) {
+    for (unsigned i = 0; i < net_count; ++i) {
         if (get_net_cells_partition(i, 1) == 0) {
             out << "\tn" << i << " [shape=box label=\"net " << i << "\"];\n";
         }
@@ -74,7 +127,7 @@ void Graph::dump(std::ostream& out) const {
 
     // cells of partition 0
     out << "{ rank = same; \n";
-    for (unsigned i = 0; i < cells.size(); ++i) {
+    for (unsigned i = 0; i < get_cell_count(); ++i) {
         if (!partitionment[i]) {
             out << "\tc" << i << " [label=\"cell " << i << "\"];\n";
         }
@@ -83,7 +136,7 @@ void Graph::dump(std::ostream& out) const {
     
     // cut nets
     out << "{ rank = same; \n";
-    for (unsigned i = 0; i < nets.size(); ++i) {
+    for (unsigned i = 0; i < net_count; ++i) {
         if (is_net_cut(i)) {
             out << "\tn" << i << " [shape=box label=\"net " << i << "\" color=blue];\n";
         }
@@ -92,7 +145,7 @@ void Graph::dump(std::ostream& out) const {
 
     // cells of partition 1
     out << "{ rank = same; \n";
-    for (unsigned i = 0; i < cells.size(); ++i) {
+    for (unsigned i = 0; i < get_cell_count(); ++i) {
         if (partitionment[i]) {
             out << "\tc" << i << " [label=\"cell " << i << "\" color=red];\n";
         }
@@ -101,38 +154,42 @@ void Graph::dump(std::ostream& out) const {
 
     // internal nets to partition 1
     out << "{ rank = max; \n";
-    for (unsigned i = 0; i < nets.size(); ++i) {
+    for (unsigned i = 0; i < net_count; ++i) {
         if (get_net_cells_partition(i, 0) == 0)
             out << "\tn" << i << " [shape=box label=\"net " << i << "\"];\n";
     }
     out << "}\n";
 
     // nets internal to partition 0
-    for (unsigned i = 0; i < nets.size(); ++i)
+    for (unsigned i = 0; i < net_count; ++i)
         if (get_net_cells_partition(i, 1) == 0)
-            for (const auto cell: nets[i])
+            for_each_net_cell(i, [&](unsigned cell) {
                 out << "\tn" << i << " -> c" << cell << ";\n";
+            });
 
     // cells of partition 0
-    for (unsigned i = 0; i < cells.size(); ++i)
+    for (unsigned i = 0; i < get_cell_count(); ++i)
         if (!partitionment[i])
-            for (const auto net: cells[i])
+            for_each_cell_net(i, [&](unsigned net) {
                 if (is_net_cut(net))
                     out << "\tc" << i << " -> n" << net << ";\n";
+            });
     
     // cut nets
-    for (unsigned i = 0; i < nets.size(); ++i)
+    for (unsigned i = 0; i < net_count; ++i)
         if (is_net_cut(i))
-            for (const auto cell: nets[i])
+            for_each_net_cell(i, [&](unsigned cell) {
                 if (partitionment[cell])
                     out << "\tn" << i << " -> c" << cell << ";\n";
+            });
 
     // cells of partition 1
-    for (unsigned i = 0; i < cells.size(); ++i)
+    for (unsigned i = 0; i < get_cell_count(); ++i)
         if (partitionment[i])
-            for (const auto net: cells[i])
+            for_each_cell_net(i, [&](unsigned net) {
                 if (!is_net_cut(net))
                     out << "\tc" << i << " -> n" << net << ";\n";
+            });
 
     out << "}\n";
 }
@@ -144,6 +201,10 @@ void Graph::print_partitionment(const char* file) const {
 }
 
 void Graph::print_partitionment(std::ostream& out) const {
+    print_partitionment(out, partitionment);
+}
+
+void Graph::print_partitionment(std::ostream& out, const std::vector<bool>& partitionment) {
     for (const auto part: partitionment)
         out << (int) part << '\n';
 }
@@ -160,7 +221,7 @@ void Graph::set_partitionment(std::vector<bool>&& new_partitionment) {
 
 unsigned Graph::get_partitionment_cost() const {
     int cost = 0;
-    for (unsigned i = 0; i < nets.size(); ++i) {
+    for (unsigned i = 0; i < net_count; ++i) {
         if (is_net_cut(i))
             ++cost;
     }
@@ -191,8 +252,12 @@ void Graph::update_disbalance() {
 }
 
 int Graph::get_net_cells_partition(unsigned net, bool partition) const {
-    return std::count_if(nets[net].begin(), nets[net].end(), 
-            [partition, this](int cell) { return partitionment[cell] == partition; });
+    int count = 0;
+    for_each_net_cell(net, [partition, &count, this](unsigned cell) {
+        count += partitionment[cell] == partition;
+    });
+
+    return count;
 }
 
 bool Graph::is_net_cut(unsigned net) const {
@@ -201,8 +266,13 @@ bool Graph::is_net_cut(unsigned net) const {
 
 unsigned Graph::get_max_degree() const {
     unsigned degree = 0;
-    for (const auto& cell: cells)
-        degree = std::max<unsigned>(degree, cell.size());
+    if (compact) {
+        for (unsigned i = 0; i < get_cell_count(); ++i)
+            degree = std::max<unsigned>(degree, packed_cells.row_size(i));
+    } else {
+        for (const auto& cell: cells)
+            degree = std::max<unsigned>(degree, cell.size());
+    }
 
     return degree;
 }
@@ -6,21 +6,39 @@
 #include <iostream>
 #include <vector>
 
+#include "pin_array.h"
+
 class Graph {
 public:
-    Graph(const char *file);
+    Graph(const char *file, bool compact = false);
     void dump(std::ostream& out = std::cout) const;
     void dump(const char* file) const;
     void print_partitionment(std::ostream& out) const;
     void print_partitionment(const char* file) const;
+    static void print_partitionment(std::ostream& out, const std::vector<bool>& partitionment);
+
+    // pin lists are either kept as std::list or compressed in compact mode
+    template <class F>
+    void for_each_cell_net(unsigned i, F f) const {
+        if (compact)
+            packed_cells.for_each(i, f);
+        else
+            for (const auto net: cells[i])
+                f(net);
+    }
+    unsigned get_cell_count() const { return partitionment.size(); }
 
-    const auto& get_cells() const { return cells; }
-    const auto& ith_cell_nets(unsigned i) const { return cells[i]; }
-    unsigned get_cell_count() const { return cells.size(); }
+    template <class F>
+    void for_each_net_cell(unsigned i, F f) const {
+        if (compact)
+            packed_nets.for_each(i, f);
+        else
+            for (const auto cell: nets[i])
+                f(cell);
+    }
+    unsigned get_net_count() const { return net_count; }
 
-    const auto& get_nets() const { return nets; }
-    const auto& ith_net_cells(unsigned i) const { return nets[i]; }
-    unsigned get_net_count() const { return nets.size(); }
+    unsigned long long get_pin_count() const { return pin_count; }
     
     const auto& get_partitionment() const { return partitionment; }
     auto get_ith_cell_partition(unsigned i) const { return partitionment[i]; }
@@ -38,8 +56,17 @@ public:
     unsigned get_max_degree() const;
 
 private:
+    void read_lists(std::istream& in);
+    void read_compact(std::istream& in);
+
+    bool compact;
     std::vector<std::list<unsigned>> cells;
     std::vector<std::list<unsigned>> nets;
+    PinArray packed_cells;
+    PinArray packed_nets;
+    unsigned net_count;
+    unsigned long long pin_count = 0;
+
     std::vector<bool> partitionment;
     int disbalance;
 };
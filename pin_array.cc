@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "pin_array.h"
+
+// num_bytes is expected to be an upper bound: growing bytes would copy them,
+// doubling resident memory for a moment
+// unused capacity is never touched, so it is not resident, but this relies on lazy overcommit:
+// with vm.overcommit_memory=2 or ulimit -v the whole bound is committed or may not be available,
+// in the latter case bytes just grow as rows are pushed
+void PinArray::reserve(unsigned num_rows, uint64_t num_bytes) {
+    offsets.reserve(num_rows + 1);
+    blocks.reserve((num_rows >> BLOCK_SHIFT) + 1);
+    try {
+        bytes.reserve(num_bytes);
+    } catch (const std::bad_alloc&) {
+    }
+    if (offsets.empty())
+        push_offset(0);
+}
+
+void PinArray::push_row(std::vector<unsigned> *row) {
+    std::sort(row->begin(), row->end());
+    row->erase(std::unique(row->begin(), row->end()), row->end());
+
+    if (offsets.empty())
+        push_offset(0);
+
+    size_t size = 0;
+    unsigned prev = 0;
+    for (const auto value: *row) {
+        size += varint_size(value - prev);
+        prev = value;
+    }
+
+    size_t pos = bytes.size();
+    bytes.resize(pos + size);
+
+    uint8_t *p = bytes.data() + pos;
+    prev = 0;
+    for (const auto value: *row) {
+        p = write_varint(p, value - prev);
+        prev = value;
+    }
+
+    push_offset(bytes.size());
+}
+
+// builds column-wise view of other: row i of this contains indices of other's rows containing i
+// rows of other are visited in increasing order, so the result is sorted without extra sorting
+void PinArray::build_transposed(const PinArray& other, unsigned num_rows) {
+    std::vector<unsigned> last(num_rows, 0); // previous index written to each row, for deltas
+    std::vector<uint32_t> cursor(num_rows, 0); // size of each row, then fill position inside it
+
+    // first: sizes of rows in bytes
+    for (unsigned i = 0; i < other.row_count(); ++i) {
+        other.for_each(i, [&](unsigned row) {
+            cursor[row] += varint_size(i - last[row]);
+            last[row] = i;
+        });
+    }
+
+    offsets.clear();
+    blocks.clear();
+    wide_offsets.clear();
+    reserve(num_rows, 0);
+
+    uint64_t size = 0;
+    for (unsigned i = 0; i < num_rows; ++i) {
+        size += cursor[i];
+        push_offset(size);
+    }
+
+    std::vector<uint8_t>(size).swap(bytes);
+
+    // second: filling
+    std::fill(last.begin(), last.end(), 0);
+    std::fill(cursor.begin(), cursor.end(), 0);
+    for (unsigned i = 0; i < other.row_count(); ++i) {
+        other.for_each(i, [&](unsigned row) {
+            uint8_t *start = bytes.data() + offset(row);
+            cursor[row] = write_varint(start + cursor[row], i - last[row]) - start;
+            last[row] = i;
+        });
+    }
+}
+
+void PinArray::push_offset(uint64_t offset) {
+    unsigned row = offsets.size();
+    unsigned pos = row & (BLOCK_SIZE - 1);
+    if (pos == 0)
+        blocks.push_back({ offset, NARROW });
+
+    Block& block = blocks.back();
+    uint64_t relative = offset - block.base;
+
+    // block size is fixed to keep lookup a shift, so there is no way to start a new base here
+    if (relative > UINT32_MAX) {
+        std::cout << "Pins of " << BLOCK_SIZE << " consecutive rows exceed 4GB, " <<
+            "not supported in compact mode\n";
+        exit(1);
+    }
+
+    if (block.wide == NARROW && relative > UINT16_MAX) { // moving offsets pushed so far aside
+        block.wide = wide_offsets.size();
+        wide_offsets.resize(wide_offsets.size() + BLOCK_SIZE);
+        std::copy(offsets.end() - pos, offsets.end(), wide_offsets.begin() + block.wide);
+    }
+
+    if (block.wide == NARROW) {
+        offsets.push_back(relative);
+    } else {
+        wide_offsets[block.wide + pos] = relative;
+        offsets.push_back(0); // unused, keeps indexing of other blocks
+    }
+}
+
+// every value ends with a byte without continuation bit
+unsigned PinArray::row_size(unsigned row) const {
+    unsigned size = 0;
+    for (uint64_t i = offset(row); i < offset(row + 1); ++i)
+        if (!(bytes[i] & 0x80))
+            ++size;
+
+    return size;
+}
+
+unsigned PinArray::varint_size(unsigned value) {
+    unsigned size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+
+    return size;
+}
+
+uint8_t *PinArray::write_varint(uint8_t *p, unsigned value) {
+    while (value >= 0x80) {
+        *p++ = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t) value;
+
+    return p;
+}
@@ -0,0 +1,67 @@
+#ifndef PIN_ARRAY_H
+#define PIN_ARRAY_H
+
+#include <cstdint>
+#include <vector>
+
+// compressed sparse rows of sorted indices
+// each row is delta-encoded and stored as LEB128 varints, decoded on the fly
+class PinArray {
+public:
+    PinArray() = default;
+
+    void reserve(unsigned num_rows, uint64_t num_bytes);
+    void push_row(std::vector<unsigned> *row); // sorts and removes duplicates
+    void build_transposed(const PinArray& other, unsigned num_rows);
+
+    template <class F>
+    void for_each(unsigned row, F f) const {
+        const uint8_t *p = bytes.data() + offset(row);
+        const uint8_t *end = bytes.data() + offset(row + 1);
+        unsigned value = 0;
+        while (p < end) {
+            unsigned delta = 0;
+            for (unsigned shift = 0; ; shift += 7) {
+                uint8_t byte = *p++;
+                delta |= (unsigned) (byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    break;
+            }
+            value += delta;
+            f(value);
+        }
+    }
+
+    unsigned row_count() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    unsigned row_size(unsigned row) const;
+
+private:
+    static unsigned varint_size(unsigned value);
+    static uint8_t *write_varint(uint8_t *p, unsigned value);
+
+    // row offsets are 16 bit relative to 64 bit base of their block of rows
+    // blocks with huge rows (e.g. clock nets) switch to 32 bit offsets stored aside
+    static const unsigned BLOCK_SHIFT = 7;
+    static const unsigned BLOCK_SIZE = 1u << BLOCK_SHIFT;
+    static const uint32_t NARROW = UINT32_MAX;
+
+    struct Block {
+        uint64_t base;
+        uint32_t wide; // start of block's offsets in wide_offsets, NARROW if not used
+    };
+
+    uint64_t offset(unsigned row) const {
+        const Block& block = blocks[row >> BLOCK_SHIFT];
+        if (block.wide == NARROW)
+            return block.base + offsets[row];
+        return block.base + wide_offsets[block.wide + (row & (BLOCK_SIZE - 1))];
+    }
+    void push_offset(uint64_t offset);
+
+    std::vector<uint8_t> bytes;
+    std::vector<uint16_t> offsets;
+    std::vector<Block> blocks;
+    std::vector<uint32_t> wide_offsets;
+};
+
+#endif // PIN_ARRAY_H